@@ -21,12 +21,18 @@ DISPLAY_ERR_INVALID_PARAM = 3
 typedef uint8_t Display_BrightnessType;
 
 
+/* Flush observer: called with the committed framebuffer on every (non-deferred) flush */
+typedef void (*Display_FlushHookType)(const uint32_t *framebuffer, uint16_t width, uint16_t height, void *ctx);
+
+
 /* Basic display handle */
 typedef struct {
 bool initialized;
 Display_BrightnessType brightness;
 uint16_t width;
 uint16_t height;
+uint8_t batchDepth;    /* >0 while inside Display_BeginBatch/Display_EndBatch */
+bool flushPending;     /* a flush was requested while batched */
 } Display_HandleType;
 
 
@@ -54,6 +60,14 @@ Display_ReturnType Display_DrawText(Display_HandleType *handle, uint16_t x, uint
 Display_ReturnType Display_DrawProgress(Display_HandleType *handle, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t percent);
 
 
+/* Fill rectangle with a solid color (does not flush) */
+Display_ReturnType Display_FillRect(Display_HandleType *handle, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t color);
+
+
+/* Blit srcW x srcH pixels from srcBuffer to dstX,dstY */
+Display_ReturnType Display_Blit(Display_HandleType *handle, const uint32_t *srcBuffer, uint16_t srcW, uint16_t srcH, uint16_t dstX, uint16_t dstY);
+
+
 /* Set brightness */
 Display_ReturnType Display_SetBrightness(Display_HandleType *handle, Display_BrightnessType level);
 
@@ -62,6 +76,15 @@ Display_ReturnType Display_SetBrightness(Display_HandleType *handle, Display_Bri
 Display_ReturnType Display_Flush(Display_HandleType *handle);
 
 
+/* Batch drawing: flushes requested between Begin/End are coalesced into one flush at End */
+Display_ReturnType Display_BeginBatch(Display_HandleType *handle);
+Display_ReturnType Display_EndBatch(Display_HandleType *handle);
+
+
+/* Install (or clear with NULL) the flush observer, e.g. a recorder or mirror */
+Display_ReturnType Display_SetFlushHook(Display_FlushHookType hook, void *ctx);
+
+
 /* Diagnostics */
 uint32_t Display_GetErrorCode(void);
 
@@ -0,0 +1,158 @@
+#ifndef DISPLAY_STREAM_H
+#define DISPLAY_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "display.h"
+
+/* ===================== display_stream.h ===================== */
+/* Delta-compressed framebuffer recording / mirroring.
+
+   Stream layout (all integers little-endian):
+     keyframe : "DSTM" u8 version u16 width u16 height u32 frameNo rows... end
+     delta    : "DSDF" u32 frameNo rows... end
+     row      : u16 y u16 x0 u16 count, then tokens covering count pixels
+     token    : u16 n; n & 0x8000 -> run of (n & 0x7FFF) copies of one u32
+                       otherwise  -> n literal u32 values
+     end      : u16 0xFFFF u32 frameBytes u32 crc
+                (both cover the magic through the 0xFFFF marker; crc is CRC-32/IEEE)
+   Token values are XOR deltas against the previous frame (against black
+   for keyframes). Only rows that changed are emitted, trimmed to the
+   first..last changed pixel.
+
+   Every keyframe carries the full stream header, so a decoder can start at
+   any keyframe: it drops data until the first one, and after a damaged
+   frame (bad row data, frameBytes or crc mismatch) it skips to the next one. */
+
+
+#define DISPLAY_STREAM_VERSION          3
+#define DISPLAY_STREAM_CHUNK_SIZE       4096
+#define DISPLAY_STREAM_KEYFRAME_DEFAULT 300   /* 5 s at 60 fps */
+#define DISPLAY_STREAM_QUEUE_DEFAULT    (2u * 1024u * 1024u)  /* > one 800x480 keyframe */
+
+
+typedef enum {
+DISPLAY_STREAM_OK = 0,
+DISPLAY_STREAM_END = 1,             /* decoder: clean end of stream */
+DISPLAY_STREAM_ERR_IO = 2,
+DISPLAY_STREAM_ERR_FORMAT = 3,
+DISPLAY_STREAM_ERR_NOMEM = 4,
+DISPLAY_STREAM_ERR_INVALID_PARAM = 5
+} DisplayStream_ReturnType;
+
+
+/* Byte sink: write all len bytes, return 0 on success.
+   write(ctx, NULL, 0) marks the end of a complete frame; plain sinks ignore it. */
+typedef int (*DisplayStream_WriteFn)(void *ctx, const void *data, size_t len);
+
+/* Byte source: read up to max bytes, return count read (0 on end/error) */
+typedef size_t (*DisplayStream_ReadFn)(void *ctx, void *data, size_t max);
+
+
+typedef struct {
+DisplayStream_WriteFn write;
+void *ctx;
+uint16_t width;
+uint16_t height;
+uint32_t keyframeInterval;   /* frames between keyframes, 0 = only on request */
+uint32_t frameNo;
+bool forceKey;               /* next frame is a keyframe (start, request, failed write) */
+uint32_t *prev;              /* last encoded frame */
+uint32_t frameBytes;         /* bytes emitted for the frame being encoded */
+uint32_t frameCrc;           /* running CRC of those bytes */
+size_t outLen;
+uint8_t out[DISPLAY_STREAM_CHUNK_SIZE];
+uint64_t rawBytes;           /* diagnostics: uncompressed bytes seen */
+uint64_t encodedBytes;       /* diagnostics: bytes handed to the sink */
+DisplayStream_ReturnType lastError;
+} DisplayStream_EncoderType;
+
+
+typedef struct {
+DisplayStream_ReadFn read;
+void *ctx;
+uint16_t width;
+uint16_t height;
+uint32_t frameNo;            /* number of the last decoded frame */
+uint32_t *frame;             /* reconstructed framebuffer, width * height */
+bool synced;                 /* last frame decoded cleanly; deltas may follow */
+bool keyPending;             /* keyframe header already read by DecoderInit */
+uint32_t skippedFrames;      /* diagnostics: damaged frames dropped */
+uint64_t consumed;           /* bytes read from the source */
+uint64_t frameStart;         /* value of consumed at the current frame's magic */
+uint32_t frameCrc;           /* running CRC of the bytes since frameStart */
+uint8_t *hist;               /* bytes of the current frame, for rescanning after damage */
+size_t histLen;
+size_t histLimit;            /* largest valid frame */
+size_t histCap;
+uint8_t *replay;             /* bytes queued to be read again after a rewind */
+size_t replayPos;
+size_t replayLen;
+size_t inPos;
+size_t inLen;
+uint8_t in[DISPLAY_STREAM_CHUNK_SIZE];
+} DisplayStream_DecoderType;
+
+
+/* Non-blocking bounded send queue for a live mirror. Only complete frames
+   are sent; a frame that does not fit is dropped whole, so a stalled reader
+   never blocks Display_Flush. */
+typedef struct {
+int fd;
+uint8_t *buf;
+size_t capacity;
+size_t head;                 /* next byte to send */
+size_t committed;            /* end of the last complete frame */
+size_t len;                  /* end of queued data */
+uint32_t droppedFrames;      /* diagnostics: frames dropped because the queue was full */
+bool failed;                 /* peer gone: every further write fails */
+} DisplayStream_QueueType;
+
+
+/* Encoder. The first frame, and the one after any failed write, is a keyframe. */
+DisplayStream_ReturnType DisplayStream_EncoderInit(DisplayStream_EncoderType *enc, DisplayStream_WriteFn write, void *ctx,
+                                                   uint16_t width, uint16_t height, uint32_t keyframeInterval);
+DisplayStream_ReturnType DisplayStream_EncodeFrame(DisplayStream_EncoderType *enc, const uint32_t *framebuffer);
+DisplayStream_ReturnType DisplayStream_RequestKeyframe(DisplayStream_EncoderType *enc);   /* e.g. a new mirror connected */
+DisplayStream_ReturnType DisplayStream_EncoderDeinit(DisplayStream_EncoderType *enc);
+
+
+/* Record every Display_Flush through enc (replaces any installed flush hook) */
+Display_ReturnType DisplayStream_Attach(DisplayStream_EncoderType *enc);
+Display_ReturnType DisplayStream_Detach(void);
+
+
+/* Decoder: skips to the first keyframe and takes the frame size from its header.
+   Besides the frame it holds two frame-sized byte buffers for rescanning damaged data. */
+DisplayStream_ReturnType DisplayStream_DecoderInit(DisplayStream_DecoderType *dec, DisplayStream_ReadFn read, void *ctx);
+DisplayStream_ReturnType DisplayStream_DecodeFrame(DisplayStream_DecoderType *dec);
+DisplayStream_ReturnType DisplayStream_DecoderDeinit(DisplayStream_DecoderType *dec);
+
+
+/* Player: decode the next frame and present it on a display (e.g. rear-seat mirror) */
+DisplayStream_ReturnType DisplayStream_PlayFrame(DisplayStream_DecoderType *dec, Display_HandleType *display);
+
+
+/* Stock sinks/sources. File: ctx is a FILE *. Fd: ctx is an int * (pipe or socket). */
+int DisplayStream_FileWrite(void *ctx, const void *data, size_t len);
+size_t DisplayStream_FileRead(void *ctx, void *data, size_t max);
+int DisplayStream_FdWrite(void *ctx, const void *data, size_t len);
+size_t DisplayStream_FdRead(void *ctx, void *data, size_t max);
+
+
+/* Mirror queue: ctx for DisplayStream_QueueWrite is the queue. Init switches fd
+   to non-blocking mode. Pump sends queued frames without blocking; it also runs
+   at every frame boundary, and can be called when idle. */
+DisplayStream_ReturnType DisplayStream_QueueInit(DisplayStream_QueueType *q, int fd, size_t capacity);
+int DisplayStream_QueueWrite(void *ctx, const void *data, size_t len);
+DisplayStream_ReturnType DisplayStream_QueuePump(DisplayStream_QueueType *q);
+DisplayStream_ReturnType DisplayStream_QueueDeinit(DisplayStream_QueueType *q);
+
+
+/* Local (AF_UNIX) socket helpers for mirroring; return a file descriptor or -1 */
+int DisplayStream_SocketConnect(const char *path);
+int DisplayStream_SocketAccept(const char *path);   /* bind path, block until one peer connects */
+
+
+#endif /* DISPLAY_STREAM_H */
@@ -0,0 +1,112 @@
+#ifndef DISPLAY_WIDGET_H
+#define DISPLAY_WIDGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "display.h"
+#include "gear.h"
+
+/* ===================== display_widget.h ===================== */
+/* Retained-mode widget layer on top of display.h. Widgets are bound to a
+   value source and are only re-rasterized when that value or their layout
+   changes; a frame where nothing changed costs one read per widget. */
+
+
+#define DISPLAY_WIDGET_MAX_COUNT   32
+#define DISPLAY_WIDGET_LABEL_MAX   32
+#define DISPLAY_WIDGET_NO_PARENT   0xFFu
+
+/* Glyph cell used by Display_DrawText (5x7 glyph on a 6 pixel pitch) */
+#define DISPLAY_WIDGET_GLYPH_W     6
+#define DISPLAY_WIDGET_GLYPH_H     7
+
+
+/* Widget kinds */
+typedef enum {
+DISPLAY_WIDGET_CONTAINER = 0,
+DISPLAY_WIDGET_PROGRESS,
+DISPLAY_WIDGET_NUMBER,
+DISPLAY_WIDGET_LABEL,
+DISPLAY_WIDGET_GEAR
+} DisplayWidget_KindType;
+
+
+/* Value source: read(ctx) is sampled once per DisplayWidget_Update */
+typedef int32_t (*DisplayWidget_ValueFn)(const void *ctx);
+
+typedef struct {
+DisplayWidget_ValueFn read;
+const void *ctx;
+} DisplayWidget_SourceType;
+
+
+/* Single widget node. Position is relative to the parent's origin and the
+   widget must lie inside its parent's rect. */
+typedef struct {
+DisplayWidget_KindType kind;
+uint8_t parent;              /* index of parent widget or DISPLAY_WIDGET_NO_PARENT */
+uint16_t x;
+uint16_t y;
+uint16_t w;
+uint16_t h;
+uint32_t background;         /* containers only: fill color, inherited by children */
+DisplayWidget_SourceType source; /* progress/number/gear */
+const char *text;            /* label: bound text buffer */
+uint8_t maxChars;            /* number: digit count, label: character count */
+bool visible;
+bool layoutDirty;            /* position or visibility changed since last draw */
+bool drawn;                  /* drawnX/drawnY hold the rect currently on screen */
+uint16_t absX;
+uint16_t absY;
+uint16_t drawnX;
+uint16_t drawnY;
+int32_t lastValue;
+char lastText[DISPLAY_WIDGET_LABEL_MAX + 1];
+} DisplayWidget_Type;
+
+
+/* Widget tree. Parents are always added before their children, so the
+   array order is a valid top-down traversal. */
+typedef struct {
+Display_HandleType *display;
+uint32_t background;
+uint8_t count;
+bool fullRepaint;            /* repaint background and every widget on the next update */
+uint32_t redrawCount;        /* diagnostics: widgets rasterized since init */
+DisplayWidget_Type widgets[DISPLAY_WIDGET_MAX_COUNT];
+} DisplayWidget_ScreenType;
+
+
+/* Initialize an empty widget tree drawing into an initialized display */
+Display_ReturnType DisplayWidget_ScreenInit(DisplayWidget_ScreenType *screen, Display_HandleType *display, uint32_t background);
+
+
+/* Add widgets. On success *id receives the widget index. */
+Display_ReturnType DisplayWidget_AddContainer(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t background, uint8_t *id);
+Display_ReturnType DisplayWidget_AddProgress(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint16_t w, uint16_t h, DisplayWidget_SourceType source, uint8_t *id);
+Display_ReturnType DisplayWidget_AddNumber(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint8_t digits, DisplayWidget_SourceType source, uint8_t *id);
+Display_ReturnType DisplayWidget_AddLabel(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint8_t maxChars, const char *text, uint8_t *id);
+Display_ReturnType DisplayWidget_AddGear(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, DisplayWidget_SourceType source, uint8_t *id);
+
+
+/* Layout changes - take effect on the next DisplayWidget_Update */
+Display_ReturnType DisplayWidget_SetPosition(DisplayWidget_ScreenType *screen, uint8_t id, uint16_t x, uint16_t y);
+Display_ReturnType DisplayWidget_SetVisible(DisplayWidget_ScreenType *screen, uint8_t id, bool visible);
+
+
+/* Repaint the whole screen on the next update (e.g. after Display_Clear) */
+Display_ReturnType DisplayWidget_Invalidate(DisplayWidget_ScreenType *screen);
+
+
+/* Sample all sources and redraw only what changed, with at most one flush.
+   redrawn (optional) receives the number of widgets rasterized. */
+Display_ReturnType DisplayWidget_Update(DisplayWidget_ScreenType *screen, uint8_t *redrawn);
+
+
+/* Stock value sources */
+int32_t DisplayWidget_ReadInt32(const void *ctx);   /* ctx: const int32_t * */
+int32_t DisplayWidget_ReadUInt8(const void *ctx);   /* ctx: const uint8_t * */
+int32_t DisplayWidget_ReadGear(const void *ctx);    /* ctx: Gear_HandleType * */
+
+
+#endif /* DISPLAY_WIDGET_H */
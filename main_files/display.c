@@ -15,6 +15,8 @@
 
 static uint32_t *g_framebuffer = NULL;
 static uint32_t g_error_code = 0;
+static Display_FlushHookType g_flush_hook = NULL;
+static void *g_flush_hook_ctx = NULL;
 
 /* Internal prototypes */
 static Display_ReturnType drv_display_hw_init(Display_HandleType *handle);
@@ -39,6 +41,8 @@ Display_ReturnType Display_Init(Display_HandleType *handle) {
     handle->width = DISPLAY_MAX_WIDTH;
     handle->height = DISPLAY_MAX_HEIGHT;
     handle->brightness = 80;
+    handle->batchDepth = 0;
+    handle->flushPending = false;
 
     framebuffer_allocate();
 
@@ -122,6 +126,23 @@ Display_ReturnType Display_DrawProgress(Display_HandleType *handle, uint16_t x,
     return Display_Flush(handle);
 }
 
+Display_ReturnType Display_FillRect(Display_HandleType *handle, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t color) {
+    if (handle == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    if (!handle->initialized) return DISPLAY_ERR_HW;
+    if (w == 0 || h == 0) return DISPLAY_ERR_INVALID_PARAM;
+    if (x >= handle->width || y >= handle->height) return DISPLAY_OK;
+
+    /* Clip once up front so the inner loop is a plain row fill */
+    uint16_t cw = ((uint32_t)x + w > handle->width) ? (uint16_t)(handle->width - x) : w;
+    uint16_t ch = ((uint32_t)y + h > handle->height) ? (uint16_t)(handle->height - y) : h;
+
+    for (uint16_t ry = 0; ry < ch; ++ry) {
+        uint32_t *row = &g_framebuffer[(size_t)(y + ry) * handle->width + x];
+        for (uint16_t rx = 0; rx < cw; ++rx) row[rx] = color;
+    }
+    return DISPLAY_OK;
+}
+
 Display_ReturnType Display_SetBrightness(Display_HandleType *handle, Display_BrightnessType level) {
     if (handle == NULL) return DISPLAY_ERR_INVALID_PARAM;
     if (!handle->initialized) return DISPLAY_ERR_HW;
@@ -135,15 +156,45 @@ Display_ReturnType Display_Flush(Display_HandleType *handle) {
     if (handle == NULL) return DISPLAY_ERR_INVALID_PARAM;
     if (!handle->initialized) return DISPLAY_ERR_HW;
 
+    /* Inside a batch the flush is deferred to Display_EndBatch */
+    if (handle->batchDepth > 0) {
+        handle->flushPending = true;
+        return DISPLAY_OK;
+    }
+
     /* In real hardware we'd copy framebuffer to the display controller. Here we'll simulate with a log. */
 #ifdef BUILD_SIM
     /* Simulation: write first 4 pixels to stdout to show activity */
     (void)printf("Display_Flush: top-left pixels: %08X %08X %08X %08X\n",
                  g_framebuffer[0], g_framebuffer[1], g_framebuffer[2], g_framebuffer[3]);
 #endif
+    if (g_flush_hook) g_flush_hook(g_framebuffer, handle->width, handle->height, g_flush_hook_ctx);
+    return DISPLAY_OK;
+}
+
+Display_ReturnType Display_SetFlushHook(Display_FlushHookType hook, void *ctx) {
+    g_flush_hook = hook;
+    g_flush_hook_ctx = hook ? ctx : NULL;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType Display_BeginBatch(Display_HandleType *handle) {
+    if (handle == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    if (!handle->initialized) return DISPLAY_ERR_HW;
+    if (handle->batchDepth == UINT8_MAX) return DISPLAY_ERR_INVALID_PARAM;
+    ++handle->batchDepth;
     return DISPLAY_OK;
 }
 
+Display_ReturnType Display_EndBatch(Display_HandleType *handle) {
+    if (handle == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    if (!handle->initialized) return DISPLAY_ERR_HW;
+    if (handle->batchDepth == 0) return DISPLAY_ERR_INVALID_PARAM;
+    if (--handle->batchDepth > 0 || !handle->flushPending) return DISPLAY_OK;
+    handle->flushPending = false;
+    return Display_Flush(handle);
+}
+
 uint32_t Display_GetErrorCode(void) {
     return g_error_code;
 }
@@ -210,7 +261,7 @@ Display_ReturnType Display_DrawHLine(Display_HandleType *handle, uint16_t x, uin
     for (uint16_t i = 0; i < length; ++i) {
         if (coord_valid(x+i,y,handle)) g_framebuffer[(size_t)y * handle->width + (x+i)] = 0x00FFFFFFu;
     }
-    return DISPLAY_Flush(handle);
+    return Display_Flush(handle);
 }
 
 /* Draw thin vertical line */
@@ -0,0 +1,698 @@
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define DISPLAY_STREAM_HAVE_POSIX 1
+#endif
+
+#include "display_stream.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef DISPLAY_STREAM_HAVE_POSIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+/* Delta encoder/decoder for framebuffer recording and mirroring.
+   Per frame the encoder memcmp()s each row against the previous frame and
+   skips identical rows, so a static screen costs one pass over memory and a
+   handful of bytes. Changed rows are trimmed to the changed span and the
+   XOR delta is run-length coded: pixels that did not change become long
+   zero runs, and flat fills (bars, backgrounds) become runs of one value.
+   Output is staged in a fixed chunk buffer; no per-frame allocation.
+   Keyframes repeat the stream header and every frame ends with its own
+   length and CRC, which is what lets the decoder detect damage and
+   resynchronize after it.
+*/
+
+#define STREAM_MAGIC_KEY    "DSTM"
+#define STREAM_MAGIC_DELTA  "DSDF"
+#define STREAM_ROW_END      0xFFFFu
+#define STREAM_RUN_FLAG     0x8000u
+#define STREAM_TOKEN_MAX    0x7FFFu
+#define STREAM_MIN_RUN      3          /* shorter runs are cheaper as literals */
+#define STREAM_CRC_INIT     0xFFFFFFFFu
+#define STREAM_CRC_POLY     0xEDB88320u /* CRC-32/IEEE, reflected */
+
+/* Internal prototypes */
+static void encoder_flush_hook(const uint32_t *framebuffer, uint16_t width, uint16_t height, void *ctx);
+static DisplayStream_ReturnType out_flush(DisplayStream_EncoderType *enc);
+static DisplayStream_ReturnType out_put(DisplayStream_EncoderType *enc, const uint8_t *data, size_t len);
+static DisplayStream_ReturnType out_u8(DisplayStream_EncoderType *enc, uint8_t v);
+static DisplayStream_ReturnType out_u16(DisplayStream_EncoderType *enc, uint16_t v);
+static DisplayStream_ReturnType out_u32(DisplayStream_EncoderType *enc, uint32_t v);
+static DisplayStream_ReturnType encode_row(DisplayStream_EncoderType *enc, uint16_t y, const uint32_t *cur, uint32_t *prv);
+static DisplayStream_ReturnType in_get(DisplayStream_DecoderType *dec, uint8_t *data, size_t len);
+static DisplayStream_ReturnType in_u8(DisplayStream_DecoderType *dec, uint8_t *v);
+static DisplayStream_ReturnType in_u16(DisplayStream_DecoderType *dec, uint16_t *v);
+static DisplayStream_ReturnType in_u32(DisplayStream_DecoderType *dec, uint32_t *v);
+static DisplayStream_ReturnType decoder_sync(DisplayStream_DecoderType *dec);
+static void decoder_rewind(DisplayStream_DecoderType *dec);
+static DisplayStream_ReturnType decode_key_header(DisplayStream_DecoderType *dec);
+static DisplayStream_ReturnType decode_body(DisplayStream_DecoderType *dec, bool key);
+static DisplayStream_ReturnType decode_row(DisplayStream_DecoderType *dec, uint16_t y);
+static uint32_t crc_update(uint32_t crc, const uint8_t *data, size_t len);
+#ifdef DISPLAY_STREAM_HAVE_POSIX
+static ssize_t fd_send(int fd, const void *data, size_t len);
+#endif
+
+/* ----------------------------- Encoder ----------------------------- */
+
+DisplayStream_ReturnType DisplayStream_EncoderInit(DisplayStream_EncoderType *enc, DisplayStream_WriteFn write, void *ctx,
+                                                   uint16_t width, uint16_t height, uint32_t keyframeInterval) {
+    if (enc == NULL || write == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    if (width == 0 || height == 0 || height == STREAM_ROW_END) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+
+    memset(enc, 0, sizeof(*enc));
+    enc->write = write;
+    enc->ctx = ctx;
+    enc->width = width;
+    enc->height = height;
+    enc->keyframeInterval = keyframeInterval;
+    enc->forceKey = true;
+    enc->prev = (uint32_t *)calloc((size_t)width * height, sizeof(uint32_t));
+    if (enc->prev == NULL) return DISPLAY_STREAM_ERR_NOMEM;
+    return DISPLAY_STREAM_OK;
+}
+
+DisplayStream_ReturnType DisplayStream_EncodeFrame(DisplayStream_EncoderType *enc, const uint32_t *framebuffer) {
+    if (enc == NULL || framebuffer == NULL || enc->prev == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+
+    bool key = enc->forceKey ||
+               (enc->keyframeInterval != 0 && (enc->frameNo % enc->keyframeInterval) == 0);
+    if (key) memset(enc->prev, 0, (size_t)enc->width * enc->height * sizeof(uint32_t));
+
+    DisplayStream_ReturnType ret;
+    enc->frameBytes = 0;
+    enc->frameCrc = STREAM_CRC_INIT;
+    if (key) {
+        ret = out_put(enc, (const uint8_t *)STREAM_MAGIC_KEY, 4);
+        if (ret == DISPLAY_STREAM_OK) ret = out_u8(enc, DISPLAY_STREAM_VERSION);
+        if (ret == DISPLAY_STREAM_OK) ret = out_u16(enc, enc->width);
+        if (ret == DISPLAY_STREAM_OK) ret = out_u16(enc, enc->height);
+    } else {
+        ret = out_put(enc, (const uint8_t *)STREAM_MAGIC_DELTA, 4);
+    }
+    if (ret == DISPLAY_STREAM_OK) ret = out_u32(enc, enc->frameNo);
+
+    size_t rowBytes = (size_t)enc->width * sizeof(uint32_t);
+    for (uint16_t y = 0; y < enc->height && ret == DISPLAY_STREAM_OK; ++y) {
+        const uint32_t *cur = &framebuffer[(size_t)y * enc->width];
+        uint32_t *prv = &enc->prev[(size_t)y * enc->width];
+        if (memcmp(cur, prv, rowBytes) == 0) continue;
+        ret = encode_row(enc, y, cur, prv);
+    }
+
+    if (ret == DISPLAY_STREAM_OK) ret = out_u16(enc, STREAM_ROW_END);
+    uint32_t frameBytes = enc->frameBytes;
+    uint32_t crc = ~enc->frameCrc;
+    if (ret == DISPLAY_STREAM_OK) ret = out_u32(enc, frameBytes);
+    if (ret == DISPLAY_STREAM_OK) ret = out_u32(enc, crc);
+    if (ret == DISPLAY_STREAM_OK) ret = out_flush(enc);
+    if (ret == DISPLAY_STREAM_OK && enc->write(enc->ctx, NULL, 0) != 0) ret = DISPLAY_STREAM_ERR_IO;
+
+    enc->rawBytes += (uint64_t)rowBytes * enc->height;
+    ++enc->frameNo;
+    /* After a failed write the reader holds at most a damaged frame, which it
+       discards; it resumes at the keyframe sent next */
+    enc->forceKey = (ret != DISPLAY_STREAM_OK);
+    if (ret != DISPLAY_STREAM_OK) enc->outLen = 0;
+    enc->lastError = ret;
+    return ret;
+}
+
+DisplayStream_ReturnType DisplayStream_RequestKeyframe(DisplayStream_EncoderType *enc) {
+    if (enc == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    enc->forceKey = true;
+    return DISPLAY_STREAM_OK;
+}
+
+DisplayStream_ReturnType DisplayStream_EncoderDeinit(DisplayStream_EncoderType *enc) {
+    if (enc == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    DisplayStream_ReturnType ret = out_flush(enc);
+    free(enc->prev);
+    enc->prev = NULL;
+    return ret;
+}
+
+Display_ReturnType DisplayStream_Attach(DisplayStream_EncoderType *enc) {
+    if (enc == NULL || enc->prev == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    return Display_SetFlushHook(encoder_flush_hook, enc);
+}
+
+Display_ReturnType DisplayStream_Detach(void) {
+    return Display_SetFlushHook(NULL, NULL);
+}
+
+/* ----------------------------- Decoder ----------------------------- */
+
+DisplayStream_ReturnType DisplayStream_DecoderInit(DisplayStream_DecoderType *dec, DisplayStream_ReadFn read, void *ctx) {
+    if (dec == NULL || read == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+
+    memset(dec, 0, sizeof(*dec));
+    dec->read = read;
+    dec->ctx = ctx;
+
+    for (;;) {
+        DisplayStream_ReturnType ret = decoder_sync(dec);
+        if (ret != DISPLAY_STREAM_OK) return (ret == DISPLAY_STREAM_END) ? DISPLAY_STREAM_ERR_FORMAT : ret;
+        ret = decode_key_header(dec);
+        if (ret == DISPLAY_STREAM_OK) break;
+        if (ret == DISPLAY_STREAM_ERR_NOMEM) return ret;
+    }
+    dec->keyPending = true;
+    return DISPLAY_STREAM_OK;
+}
+
+DisplayStream_ReturnType DisplayStream_DecodeFrame(DisplayStream_DecoderType *dec) {
+    if (dec == NULL || dec->frame == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+
+    for (;;) {
+        DisplayStream_ReturnType ret;
+        bool key = true;
+
+        if (dec->keyPending) {
+            dec->keyPending = false;
+        } else if (!dec->synced) {
+            /* Deltas are useless without their keyframe: skip to the next one */
+            ret = decoder_sync(dec);
+            if (ret != DISPLAY_STREAM_OK) return ret;
+            if (decode_key_header(dec) != DISPLAY_STREAM_OK) { decoder_rewind(dec); continue; }
+        } else {
+            uint8_t magic[4];
+            dec->histLen = 0;
+            ret = in_get(dec, magic, sizeof(magic));
+            if (ret == DISPLAY_STREAM_END) return ret;
+            if (ret != DISPLAY_STREAM_OK) { dec->synced = false; continue; }
+            dec->frameStart = dec->consumed - sizeof(magic);
+            dec->frameCrc = crc_update(STREAM_CRC_INIT, magic, sizeof(magic));
+            if (memcmp(magic, STREAM_MAGIC_DELTA, 4) == 0) {
+                key = false;
+            } else if (memcmp(magic, STREAM_MAGIC_KEY, 4) != 0 || decode_key_header(dec) != DISPLAY_STREAM_OK) {
+                dec->synced = false;
+                ++dec->skippedFrames;
+                decoder_rewind(dec);
+                continue;
+            }
+        }
+
+        ret = decode_body(dec, key);
+        if (ret == DISPLAY_STREAM_OK) {
+            dec->synced = true;
+            return DISPLAY_STREAM_OK;
+        }
+        dec->synced = false;
+        ++dec->skippedFrames;
+        decoder_rewind(dec);
+    }
+}
+
+DisplayStream_ReturnType DisplayStream_DecoderDeinit(DisplayStream_DecoderType *dec) {
+    if (dec == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    free(dec->frame);
+    free(dec->hist);
+    free(dec->replay);
+    dec->frame = NULL;
+    dec->hist = NULL;
+    dec->replay = NULL;
+    return DISPLAY_STREAM_OK;
+}
+
+DisplayStream_ReturnType DisplayStream_PlayFrame(DisplayStream_DecoderType *dec, Display_HandleType *display) {
+    if (display == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    DisplayStream_ReturnType ret = DisplayStream_DecodeFrame(dec);
+    if (ret != DISPLAY_STREAM_OK) return ret;
+    if (Display_Blit(display, dec->frame, dec->width, dec->height, 0, 0) != DISPLAY_OK) return DISPLAY_STREAM_ERR_IO;
+    return DISPLAY_STREAM_OK;
+}
+
+/* ------------------------- Sinks and sources ------------------------- */
+
+int DisplayStream_FileWrite(void *ctx, const void *data, size_t len) {
+    if (ctx == NULL) return -1;
+    return (fwrite(data, 1, len, (FILE *)ctx) == len) ? 0 : -1;
+}
+
+size_t DisplayStream_FileRead(void *ctx, void *data, size_t max) {
+    if (ctx == NULL) return 0;
+    return fread(data, 1, max, (FILE *)ctx);
+}
+
+#ifdef DISPLAY_STREAM_HAVE_POSIX
+int DisplayStream_FdWrite(void *ctx, const void *data, size_t len) {
+    if (ctx == NULL) return -1;
+    int fd = *(const int *)ctx;
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        ssize_t n = fd_send(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+size_t DisplayStream_FdRead(void *ctx, void *data, size_t max) {
+    if (ctx == NULL) return 0;
+    int fd = *(const int *)ctx;
+    for (;;) {
+        ssize_t n = read(fd, data, max);
+        if (n < 0 && errno == EINTR) continue;
+        return (n > 0) ? (size_t)n : 0;
+    }
+}
+
+DisplayStream_ReturnType DisplayStream_QueueInit(DisplayStream_QueueType *q, int fd, size_t capacity) {
+    if (q == NULL || fd < 0 || capacity == 0) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    memset(q, 0, sizeof(*q));
+    q->fd = fd;
+    q->capacity = capacity;
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) return DISPLAY_STREAM_ERR_IO;
+    q->buf = (uint8_t *)malloc(capacity);
+    if (q->buf == NULL) return DISPLAY_STREAM_ERR_NOMEM;
+    return DISPLAY_STREAM_OK;
+}
+
+int DisplayStream_QueueWrite(void *ctx, const void *data, size_t len) {
+    DisplayStream_QueueType *q = (DisplayStream_QueueType *)ctx;
+    if (q == NULL || q->buf == NULL || q->failed) return -1;
+
+    if (data == NULL && len == 0) {
+        /* Frame complete: it may now be sent */
+        q->committed = q->len;
+        return (DisplayStream_QueuePump(q) == DISPLAY_STREAM_OK) ? 0 : -1;
+    }
+
+    if (q->len - q->head + len > q->capacity) {
+        /* Reader is too slow: drop the partial frame, keep what is complete */
+        q->len = q->committed;
+        ++q->droppedFrames;
+        return -1;
+    }
+    if (q->len + len > q->capacity) {
+        memmove(q->buf, &q->buf[q->head], q->len - q->head);
+        q->committed -= q->head;
+        q->len -= q->head;
+        q->head = 0;
+    }
+    memcpy(&q->buf[q->len], data, len);
+    q->len += len;
+    return 0;
+}
+
+DisplayStream_ReturnType DisplayStream_QueuePump(DisplayStream_QueueType *q) {
+    if (q == NULL || q->buf == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    if (q->failed) return DISPLAY_STREAM_ERR_IO;
+
+    while (q->head < q->committed) {
+        ssize_t n = fd_send(q->fd, &q->buf[q->head], q->committed - q->head);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            q->failed = true;
+            return DISPLAY_STREAM_ERR_IO;
+        }
+        q->head += (size_t)n;
+    }
+    if (q->head == q->len) q->head = q->committed = q->len = 0;
+    return DISPLAY_STREAM_OK;
+}
+
+DisplayStream_ReturnType DisplayStream_QueueDeinit(DisplayStream_QueueType *q) {
+    if (q == NULL) return DISPLAY_STREAM_ERR_INVALID_PARAM;
+    free(q->buf);
+    q->buf = NULL;
+    return DISPLAY_STREAM_OK;
+}
+
+int DisplayStream_SocketConnect(const char *path) {
+    if (path == NULL) return -1;
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int DisplayStream_SocketAccept(const char *path) {
+    if (path == NULL) return -1;
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) return -1;
+    (void)unlink(path);
+    if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(lfd, 1) != 0) {
+        close(lfd);
+        return -1;
+    }
+    int fd;
+    do {
+        fd = accept(lfd, NULL, NULL);
+    } while (fd < 0 && errno == EINTR);
+    close(lfd);
+    (void)unlink(path);
+    return fd;
+}
+#else
+DisplayStream_ReturnType DisplayStream_QueueInit(DisplayStream_QueueType *q, int fd, size_t capacity) { (void)q; (void)fd; (void)capacity; return DISPLAY_STREAM_ERR_IO; }
+int DisplayStream_QueueWrite(void *ctx, const void *data, size_t len) { (void)ctx; (void)data; (void)len; return -1; }
+DisplayStream_ReturnType DisplayStream_QueuePump(DisplayStream_QueueType *q) { (void)q; return DISPLAY_STREAM_ERR_IO; }
+DisplayStream_ReturnType DisplayStream_QueueDeinit(DisplayStream_QueueType *q) { (void)q; return DISPLAY_STREAM_OK; }
+int DisplayStream_FdWrite(void *ctx, const void *data, size_t len) { (void)ctx; (void)data; (void)len; return -1; }
+size_t DisplayStream_FdRead(void *ctx, void *data, size_t max) { (void)ctx; (void)data; (void)max; return 0; }
+int DisplayStream_SocketConnect(const char *path) { (void)path; return -1; }
+int DisplayStream_SocketAccept(const char *path) { (void)path; return -1; }
+#endif
+
+/* ----------------- Internal helper implementations ----------------- */
+static void encoder_flush_hook(const uint32_t *framebuffer, uint16_t width, uint16_t height, void *ctx) {
+    DisplayStream_EncoderType *enc = (DisplayStream_EncoderType *)ctx;
+    if (width != enc->width || height != enc->height) {
+        enc->lastError = DISPLAY_STREAM_ERR_INVALID_PARAM;
+        return;
+    }
+    (void)DisplayStream_EncodeFrame(enc, framebuffer);
+}
+
+static DisplayStream_ReturnType out_flush(DisplayStream_EncoderType *enc) {
+    if (enc->outLen == 0) return DISPLAY_STREAM_OK;
+    if (enc->write(enc->ctx, enc->out, enc->outLen) != 0) return DISPLAY_STREAM_ERR_IO;
+    enc->encodedBytes += enc->outLen;
+    enc->outLen = 0;
+    return DISPLAY_STREAM_OK;
+}
+
+static DisplayStream_ReturnType out_put(DisplayStream_EncoderType *enc, const uint8_t *data, size_t len) {
+    enc->frameBytes += (uint32_t)len;
+    enc->frameCrc = crc_update(enc->frameCrc, data, len);
+    while (len > 0) {
+        if (enc->outLen == sizeof(enc->out)) {
+            DisplayStream_ReturnType ret = out_flush(enc);
+            if (ret != DISPLAY_STREAM_OK) return ret;
+        }
+        size_t n = sizeof(enc->out) - enc->outLen;
+        if (n > len) n = len;
+        memcpy(&enc->out[enc->outLen], data, n);
+        enc->outLen += n;
+        data += n;
+        len -= n;
+    }
+    return DISPLAY_STREAM_OK;
+}
+
+static DisplayStream_ReturnType out_u8(DisplayStream_EncoderType *enc, uint8_t v) {
+    return out_put(enc, &v, 1);
+}
+
+static DisplayStream_ReturnType out_u16(DisplayStream_EncoderType *enc, uint16_t v) {
+    uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    return out_put(enc, b, sizeof(b));
+}
+
+static DisplayStream_ReturnType out_u32(DisplayStream_EncoderType *enc, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    return out_put(enc, b, sizeof(b));
+}
+
+static DisplayStream_ReturnType encode_row(DisplayStream_EncoderType *enc, uint16_t y, const uint32_t *cur, uint32_t *prv) {
+    /* Trim to the changed span; the caller guarantees at least one difference */
+    uint16_t x0 = 0;
+    uint16_t x1 = (uint16_t)(enc->width - 1);
+    while (cur[x0] == prv[x0]) ++x0;
+    while (cur[x1] == prv[x1]) --x1;
+    uint16_t count = (uint16_t)(x1 - x0 + 1);
+
+    DisplayStream_ReturnType ret = out_u16(enc, y);
+    if (ret == DISPLAY_STREAM_OK) ret = out_u16(enc, x0);
+    if (ret == DISPLAY_STREAM_OK) ret = out_u16(enc, count);
+
+    const uint32_t *c = &cur[x0];
+    const uint32_t *p = &prv[x0];
+    size_t i = 0;
+    while (i < count && ret == DISPLAY_STREAM_OK) {
+        uint32_t d = c[i] ^ p[i];
+        size_t run = 1;
+        while (i + run < count && run < STREAM_TOKEN_MAX && (c[i + run] ^ p[i + run]) == d) ++run;
+
+        if (run >= STREAM_MIN_RUN) {
+            ret = out_u16(enc, (uint16_t)(STREAM_RUN_FLAG | run));
+            if (ret == DISPLAY_STREAM_OK) ret = out_u32(enc, d);
+            i += run;
+            continue;
+        }
+
+        /* Literal block: extend until a worthwhile run starts */
+        size_t start = i;
+        i += run;
+        while (i < count && i - start < STREAM_TOKEN_MAX) {
+            uint32_t e = c[i] ^ p[i];
+            if (i + 2 < count && (c[i + 1] ^ p[i + 1]) == e && (c[i + 2] ^ p[i + 2]) == e) break;
+            ++i;
+        }
+        ret = out_u16(enc, (uint16_t)(i - start));
+        for (size_t k = start; k < i && ret == DISPLAY_STREAM_OK; ++k) ret = out_u32(enc, c[k] ^ p[k]);
+    }
+
+    memcpy(&prv[x0], c, (size_t)count * sizeof(uint32_t));
+    return ret;
+}
+
+/* Reads bytes left over from a rewind first, then the source. Bytes of the
+   current frame are kept in hist so a damaged frame can be rescanned. */
+static DisplayStream_ReturnType in_get(DisplayStream_DecoderType *dec, uint8_t *data, size_t len) {
+    bool started = false;
+    while (len > 0) {
+        const uint8_t *src;
+        size_t n;
+        if (dec->replayPos < dec->replayLen) {
+            src = &dec->replay[dec->replayPos];
+            n = dec->replayLen - dec->replayPos;
+        } else {
+            if (dec->inPos == dec->inLen) {
+                dec->inLen = dec->read(dec->ctx, dec->in, sizeof(dec->in));
+                dec->inPos = 0;
+                if (dec->inLen == 0) return started ? DISPLAY_STREAM_ERR_FORMAT : DISPLAY_STREAM_END;
+            }
+            src = &dec->in[dec->inPos];
+            n = dec->inLen - dec->inPos;
+        }
+        if (n > len) n = len;
+        memcpy(data, src, n);
+        if (src == &dec->in[dec->inPos]) dec->inPos += n; else dec->replayPos += n;
+        dec->frameCrc = crc_update(dec->frameCrc, data, n);
+
+        if (dec->hist != NULL) {
+            if (dec->histLen + n <= dec->histLimit) memcpy(&dec->hist[dec->histLen], data, n);
+            dec->histLen += n; /* past histLimit the frame is invalid anyway; rewind gives up */
+        }
+        dec->consumed += n;
+        data += n;
+        len -= n;
+        started = true;
+    }
+    return DISPLAY_STREAM_OK;
+}
+
+static DisplayStream_ReturnType in_u8(DisplayStream_DecoderType *dec, uint8_t *v) {
+    return in_get(dec, v, 1);
+}
+
+static DisplayStream_ReturnType in_u16(DisplayStream_DecoderType *dec, uint16_t *v) {
+    uint8_t b[2];
+    DisplayStream_ReturnType ret = in_get(dec, b, sizeof(b));
+    if (ret == DISPLAY_STREAM_OK) *v = (uint16_t)(b[0] | (b[1] << 8));
+    return ret;
+}
+
+static DisplayStream_ReturnType in_u32(DisplayStream_DecoderType *dec, uint32_t *v) {
+    uint8_t b[4];
+    DisplayStream_ReturnType ret = in_get(dec, b, sizeof(b));
+    if (ret == DISPLAY_STREAM_OK) *v = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    return ret;
+}
+
+/* Scan for the next keyframe magic; on success the magic has just been consumed */
+static DisplayStream_ReturnType decoder_sync(DisplayStream_DecoderType *dec) {
+    uint8_t window[4] = { 0, 0, 0, 0 };
+    size_t seen = 0;
+    for (;;) {
+        uint8_t b = 0;
+        dec->histLen = 0;
+        DisplayStream_ReturnType ret = in_u8(dec, &b);
+        if (ret != DISPLAY_STREAM_OK) return DISPLAY_STREAM_END;
+        memmove(window, &window[1], 3);
+        window[3] = b;
+        if (++seen >= 4 && memcmp(window, STREAM_MAGIC_KEY, 4) == 0) {
+            dec->frameStart = dec->consumed - 4;
+            dec->frameCrc = crc_update(STREAM_CRC_INIT, window, 4);
+            if (dec->hist != NULL) {
+                memcpy(dec->hist, window, 4);
+                dec->histLen = 4;
+            }
+            return DISPLAY_STREAM_OK;
+        }
+    }
+}
+
+/* A frame failed to decode after its magic. The next keyframe may start
+   anywhere after that magic, including inside bytes already consumed, so
+   queue everything from frameStart + 1 to be read again. */
+static void decoder_rewind(DisplayStream_DecoderType *dec) {
+    if (dec->hist == NULL || dec->histLen < 2 || dec->histLen > dec->histLimit) return;
+
+    /* Unread replay bytes only remain if the source was not touched since the last rewind */
+    size_t keep = dec->histLen - 1;
+    size_t rest = dec->replayLen - dec->replayPos;
+    size_t pending = dec->inLen - dec->inPos;
+    if (keep + rest + pending > dec->histCap) return;
+
+    memmove(dec->hist, &dec->hist[1], keep);
+    memcpy(&dec->hist[keep], &dec->replay[dec->replayPos], rest);
+    memcpy(&dec->hist[keep + rest], &dec->in[dec->inPos], pending);
+
+    uint8_t *tmp = dec->replay;
+    dec->replay = dec->hist;
+    dec->replayPos = 0;
+    dec->replayLen = keep + rest + pending;
+    dec->hist = tmp;
+    dec->histLen = 0;
+    dec->inPos = dec->inLen = 0;
+}
+
+/* Keyframe header after the magic. The first one fixes the frame size. */
+static DisplayStream_ReturnType decode_key_header(DisplayStream_DecoderType *dec) {
+    uint8_t version = 0;
+    uint16_t width = 0, height = 0;
+    if (in_u8(dec, &version) != DISPLAY_STREAM_OK || version != DISPLAY_STREAM_VERSION) return DISPLAY_STREAM_ERR_FORMAT;
+    if (in_u16(dec, &width) != DISPLAY_STREAM_OK || in_u16(dec, &height) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+    if (width == 0 || height == 0 || height == STREAM_ROW_END) return DISPLAY_STREAM_ERR_FORMAT;
+
+    if (dec->frame == NULL) {
+        /* Largest valid frame: 4 bytes per pixel plus row and token headers */
+        size_t limit = (size_t)width * height * 4u + (size_t)height * 16u + 64u;
+        size_t cap = limit + DISPLAY_STREAM_CHUNK_SIZE;
+        dec->frame = (uint32_t *)calloc((size_t)width * height, sizeof(uint32_t));
+        dec->hist = (uint8_t *)malloc(cap);
+        dec->replay = (uint8_t *)malloc(cap);
+        if (dec->frame == NULL || dec->hist == NULL || dec->replay == NULL) {
+            free(dec->frame);
+            free(dec->hist);
+            free(dec->replay);
+            dec->frame = NULL;
+            dec->hist = dec->replay = NULL;
+            return DISPLAY_STREAM_ERR_NOMEM;
+        }
+        dec->width = width;
+        dec->height = height;
+        dec->histLimit = limit;
+        dec->histCap = cap;
+        dec->histLen = 0;   /* header bytes before this point were not recorded */
+    } else if (width != dec->width || height != dec->height) {
+        return DISPLAY_STREAM_ERR_FORMAT;
+    }
+    return DISPLAY_STREAM_OK;
+}
+
+/* Frame number, rows and end marker. dec->frame is only valid again once this succeeds. */
+static DisplayStream_ReturnType decode_body(DisplayStream_DecoderType *dec, bool key) {
+    uint32_t frameNo = 0;
+    if (in_u32(dec, &frameNo) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+
+    if (key) memset(dec->frame, 0, (size_t)dec->width * dec->height * sizeof(uint32_t));
+
+    for (;;) {
+        uint16_t y = 0;
+        if (in_u16(dec, &y) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+        if (y == STREAM_ROW_END) break;
+        if (y >= dec->height) return DISPLAY_STREAM_ERR_FORMAT;
+        DisplayStream_ReturnType ret = decode_row(dec, y);
+        if (ret != DISPLAY_STREAM_OK) return ret;
+    }
+
+    uint32_t expected = (uint32_t)(dec->consumed - dec->frameStart);
+    uint32_t expectedCrc = ~dec->frameCrc;
+    uint32_t frameBytes = 0, crc = 0;
+    if (in_u32(dec, &frameBytes) != DISPLAY_STREAM_OK || frameBytes != expected) return DISPLAY_STREAM_ERR_FORMAT;
+    if (in_u32(dec, &crc) != DISPLAY_STREAM_OK || crc != expectedCrc) return DISPLAY_STREAM_ERR_FORMAT;
+
+    dec->frameNo = frameNo;
+    return DISPLAY_STREAM_OK;
+}
+
+static DisplayStream_ReturnType decode_row(DisplayStream_DecoderType *dec, uint16_t y) {
+    uint16_t x0 = 0, count = 0;
+    if (in_u16(dec, &x0) != DISPLAY_STREAM_OK || in_u16(dec, &count) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+    if (count == 0 || (uint32_t)x0 + count > dec->width) return DISPLAY_STREAM_ERR_FORMAT;
+
+    uint32_t *row = &dec->frame[(size_t)y * dec->width + x0];
+    size_t i = 0;
+    while (i < count) {
+        uint16_t token = 0;
+        if (in_u16(dec, &token) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+        size_t n = token & STREAM_TOKEN_MAX;
+        if (n == 0 || i + n > count) return DISPLAY_STREAM_ERR_FORMAT;
+
+        if (token & STREAM_RUN_FLAG) {
+            uint32_t d = 0;
+            if (in_u32(dec, &d) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+            if (d == 0) { i += n; continue; }
+            for (size_t k = 0; k < n; ++k) row[i + k] ^= d;
+        } else {
+            for (size_t k = 0; k < n; ++k) {
+                uint32_t d = 0;
+                if (in_u32(dec, &d) != DISPLAY_STREAM_OK) return DISPLAY_STREAM_ERR_FORMAT;
+                row[i + k] ^= d;
+            }
+        }
+        i += n;
+    }
+    return DISPLAY_STREAM_OK;
+}
+
+/* Table-driven CRC-32; the table is built on first use */
+static uint32_t crc_update(uint32_t crc, const uint8_t *data, size_t len) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1u) ? (c >> 1) ^ STREAM_CRC_POLY : (c >> 1);
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+    for (size_t i = 0; i < len; ++i) crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef DISPLAY_STREAM_HAVE_POSIX
+static ssize_t fd_send(int fd, const void *data, size_t len) {
+#ifdef MSG_NOSIGNAL
+    /* A disconnected mirror must not kill the cluster with SIGPIPE */
+    ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == ENOTSOCK) n = write(fd, data, len);
+    return n;
+#else
+    return write(fd, data, len);
+#endif
+}
+#endif
@@ -0,0 +1,387 @@
+#include "display_widget.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Retained widget tree. DisplayWidget_Update runs in passes over the widget
+   array (parents precede children, later widgets paint on top):
+     1. sample each source and mark widgets whose value/layout changed
+     2. erase rects left behind by moved/hidden widgets, children first, with
+        the color of the nearest ancestor that stays on screen; mark any
+        widget overlapping an erased rect so it gets repainted
+     3. walk forward: a repainted widget paints over its children and over
+        any later widget it overlaps, so those are repainted as well
+     4. rasterize dirty widgets inside a single display batch (one flush)
+   The result always equals a full repaint. When nothing changed only pass 1
+   runs and no pixels are touched.
+*/
+
+/* Internal prototypes */
+static Display_ReturnType widget_add(DisplayWidget_ScreenType *screen, DisplayWidget_KindType kind, uint8_t parent,
+                                     uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *id, DisplayWidget_Type **out);
+static bool widget_fits_parent(const DisplayWidget_ScreenType *screen, uint8_t parent,
+                               uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+static bool widget_sample(DisplayWidget_Type *wd);
+static bool widget_is_ancestor(const DisplayWidget_ScreenType *screen, uint8_t ancestor, uint8_t id);
+static uint32_t widget_background(const DisplayWidget_ScreenType *screen, const DisplayWidget_Type *wd);
+static uint32_t widget_erase_color(const DisplayWidget_ScreenType *screen, const DisplayWidget_Type *wd,
+                                   const bool *shown, const bool *erasing);
+static inline bool rect_overlap(uint16_t ax, uint16_t ay, uint16_t aw, uint16_t ah,
+                                uint16_t bx, uint16_t by, uint16_t bw, uint16_t bh);
+static Display_ReturnType widget_draw(DisplayWidget_ScreenType *screen, DisplayWidget_Type *wd);
+static Display_ReturnType widget_draw_text(DisplayWidget_ScreenType *screen, DisplayWidget_Type *wd, uint16_t offset, const char *text);
+
+Display_ReturnType DisplayWidget_ScreenInit(DisplayWidget_ScreenType *screen, Display_HandleType *display, uint32_t background) {
+    if (screen == NULL || display == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    if (!display->initialized) return DISPLAY_ERR_HW;
+
+    memset(screen, 0, sizeof(*screen));
+    screen->display = display;
+    screen->background = background;
+    screen->fullRepaint = true;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_AddContainer(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t background, uint8_t *id) {
+    DisplayWidget_Type *wd = NULL;
+    Display_ReturnType ret = widget_add(screen, DISPLAY_WIDGET_CONTAINER, parent, x, y, w, h, id, &wd);
+    if (ret != DISPLAY_OK) return ret;
+    wd->background = background;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_AddProgress(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint16_t w, uint16_t h, DisplayWidget_SourceType source, uint8_t *id) {
+    if (source.read == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    DisplayWidget_Type *wd = NULL;
+    Display_ReturnType ret = widget_add(screen, DISPLAY_WIDGET_PROGRESS, parent, x, y, w, h, id, &wd);
+    if (ret != DISPLAY_OK) return ret;
+    wd->source = source;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_AddNumber(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint8_t digits, DisplayWidget_SourceType source, uint8_t *id) {
+    if (source.read == NULL || digits == 0 || digits > 11) return DISPLAY_ERR_INVALID_PARAM;
+    DisplayWidget_Type *wd = NULL;
+    Display_ReturnType ret = widget_add(screen, DISPLAY_WIDGET_NUMBER, parent, x, y,
+                                        (uint16_t)(digits * DISPLAY_WIDGET_GLYPH_W), DISPLAY_WIDGET_GLYPH_H, id, &wd);
+    if (ret != DISPLAY_OK) return ret;
+    wd->source = source;
+    wd->maxChars = digits;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_AddLabel(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, uint8_t maxChars, const char *text, uint8_t *id) {
+    if (text == NULL || maxChars == 0 || maxChars > DISPLAY_WIDGET_LABEL_MAX) return DISPLAY_ERR_INVALID_PARAM;
+    DisplayWidget_Type *wd = NULL;
+    Display_ReturnType ret = widget_add(screen, DISPLAY_WIDGET_LABEL, parent, x, y,
+                                        (uint16_t)(maxChars * DISPLAY_WIDGET_GLYPH_W), DISPLAY_WIDGET_GLYPH_H, id, &wd);
+    if (ret != DISPLAY_OK) return ret;
+    wd->text = text;
+    wd->maxChars = maxChars;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_AddGear(DisplayWidget_ScreenType *screen, uint8_t parent, uint16_t x, uint16_t y, DisplayWidget_SourceType source, uint8_t *id) {
+    if (source.read == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    DisplayWidget_Type *wd = NULL;
+    Display_ReturnType ret = widget_add(screen, DISPLAY_WIDGET_GEAR, parent, x, y,
+                                        DISPLAY_WIDGET_GLYPH_W, DISPLAY_WIDGET_GLYPH_H, id, &wd);
+    if (ret != DISPLAY_OK) return ret;
+    wd->source = source;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_SetPosition(DisplayWidget_ScreenType *screen, uint8_t id, uint16_t x, uint16_t y) {
+    if (screen == NULL || id >= screen->count) return DISPLAY_ERR_INVALID_PARAM;
+    DisplayWidget_Type *wd = &screen->widgets[id];
+    if (wd->x == x && wd->y == y) return DISPLAY_OK;
+    if (!widget_fits_parent(screen, wd->parent, x, y, wd->w, wd->h)) return DISPLAY_ERR_INVALID_PARAM;
+    wd->x = x;
+    wd->y = y;
+    wd->layoutDirty = true;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_SetVisible(DisplayWidget_ScreenType *screen, uint8_t id, bool visible) {
+    if (screen == NULL || id >= screen->count) return DISPLAY_ERR_INVALID_PARAM;
+    DisplayWidget_Type *wd = &screen->widgets[id];
+    if (wd->visible == visible) return DISPLAY_OK;
+    wd->visible = visible;
+    wd->layoutDirty = true;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_Invalidate(DisplayWidget_ScreenType *screen) {
+    if (screen == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    screen->fullRepaint = true;
+    return DISPLAY_OK;
+}
+
+Display_ReturnType DisplayWidget_Update(DisplayWidget_ScreenType *screen, uint8_t *redrawn) {
+    if (screen == NULL || screen->display == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    if (!screen->display->initialized) return DISPLAY_ERR_HW;
+
+    bool dirty[DISPLAY_WIDGET_MAX_COUNT];
+    bool shown[DISPLAY_WIDGET_MAX_COUNT];
+    bool erasing[DISPLAY_WIDGET_MAX_COUNT];
+    bool any_dirty = false;
+    bool any_erase = false;
+    uint8_t count = 0;
+
+    if (redrawn) *redrawn = 0;
+
+    /* Full repaint: the whole screen is repainted, so nothing needs erasing */
+    bool full = screen->fullRepaint;
+    if (full) {
+        for (uint8_t i = 0; i < screen->count; ++i) screen->widgets[i].drawn = false;
+    }
+
+    /* Pass 1: resolve absolute layout and sample bound values */
+    for (uint8_t i = 0; i < screen->count; ++i) {
+        DisplayWidget_Type *wd = &screen->widgets[i];
+        bool parent_visible = true;
+        uint16_t ox = 0, oy = 0;
+        if (wd->parent != DISPLAY_WIDGET_NO_PARENT) {
+            const DisplayWidget_Type *p = &screen->widgets[wd->parent];
+            ox = p->absX;
+            oy = p->absY;
+            parent_visible = shown[wd->parent];
+            if (p->layoutDirty) wd->layoutDirty = true; /* parent moved: child moves with it */
+        }
+        wd->absX = (uint16_t)(ox + wd->x);
+        wd->absY = (uint16_t)(oy + wd->y);
+
+        bool changed = widget_sample(wd);
+        shown[i] = parent_visible && wd->visible;
+        if (!shown[i] && wd->drawn) wd->layoutDirty = true; /* hidden, possibly via an ancestor */
+        erasing[i] = wd->layoutDirty && wd->drawn;
+        any_erase = any_erase || erasing[i];
+        dirty[i] = shown[i] && (changed || wd->layoutDirty || !wd->drawn);
+        any_dirty = any_dirty || dirty[i];
+    }
+
+    if (!full && !any_dirty && !any_erase) {
+        for (uint8_t i = 0; i < screen->count; ++i) screen->widgets[i].layoutDirty = false;
+        return DISPLAY_OK;
+    }
+
+    Display_ReturnType ret = Display_BeginBatch(screen->display);
+    if (ret != DISPLAY_OK) return ret;
+
+    if (full) {
+        (void)Display_FillRect(screen->display, 0, 0, screen->display->width, screen->display->height, screen->background);
+        screen->fullRepaint = false;
+    }
+
+    /* Pass 2: erase stale rects of moved/hidden widgets, children before parents */
+    if (any_erase) {
+        for (uint8_t i = screen->count; i-- > 0;) {
+            DisplayWidget_Type *wd = &screen->widgets[i];
+            if (!erasing[i]) continue;
+
+            (void)Display_FillRect(screen->display, wd->drawnX, wd->drawnY, wd->w, wd->h,
+                                   widget_erase_color(screen, wd, shown, erasing));
+            wd->drawn = false;
+
+            for (uint8_t j = 0; j < screen->count; ++j) {
+                const DisplayWidget_Type *other = &screen->widgets[j];
+                if (j == i || !shown[j] || widget_is_ancestor(screen, j, i)) continue;
+                if (rect_overlap(wd->drawnX, wd->drawnY, wd->w, wd->h, other->absX, other->absY, other->w, other->h)) {
+                    dirty[j] = true;
+                }
+            }
+        }
+    }
+
+    /* Pass 3: a repainted widget covers its children and any later widget it overlaps.
+       Marks only move forward, so one pass in draw order reaches the fixed point. */
+    for (uint8_t i = 0; i < screen->count; ++i) {
+        const DisplayWidget_Type *wd = &screen->widgets[i];
+        if (!shown[i]) { dirty[i] = false; continue; }
+        if (wd->parent != DISPLAY_WIDGET_NO_PARENT && dirty[wd->parent]) dirty[i] = true;
+        if (!dirty[i]) continue;
+
+        for (uint8_t j = (uint8_t)(i + 1); j < screen->count; ++j) {
+            const DisplayWidget_Type *other = &screen->widgets[j];
+            if (dirty[j] || !shown[j]) continue;
+            if (rect_overlap(wd->absX, wd->absY, wd->w, wd->h, other->absX, other->absY, other->w, other->h)) {
+                dirty[j] = true;
+            }
+        }
+    }
+
+    /* Pass 4: rasterize */
+    for (uint8_t i = 0; i < screen->count; ++i) {
+        DisplayWidget_Type *wd = &screen->widgets[i];
+        wd->layoutDirty = false;
+        if (!dirty[i]) continue;
+        if (widget_draw(screen, wd) != DISPLAY_OK) continue;
+        wd->drawn = true;
+        wd->drawnX = wd->absX;
+        wd->drawnY = wd->absY;
+        ++count;
+    }
+
+    screen->redrawCount += count;
+    if (redrawn) *redrawn = count;
+
+    /* Erases and container fills do not request a flush on their own */
+    (void)Display_Flush(screen->display);
+    return Display_EndBatch(screen->display);
+}
+
+int32_t DisplayWidget_ReadInt32(const void *ctx) {
+    if (ctx == NULL) return 0;
+    return *(const int32_t *)ctx;
+}
+
+int32_t DisplayWidget_ReadUInt8(const void *ctx) {
+    if (ctx == NULL) return 0;
+    return (int32_t)*(const uint8_t *)ctx;
+}
+
+int32_t DisplayWidget_ReadGear(const void *ctx) {
+    /* Gear_GetPosition only reads the handle */
+    return (int32_t)Gear_GetPosition((Gear_HandleType *)ctx);
+}
+
+/* ----------------- Internal helper implementations ----------------- */
+static Display_ReturnType widget_add(DisplayWidget_ScreenType *screen, DisplayWidget_KindType kind, uint8_t parent,
+                                     uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *id, DisplayWidget_Type **out) {
+    if (screen == NULL || id == NULL) return DISPLAY_ERR_INVALID_PARAM;
+    if (w == 0 || h == 0) return DISPLAY_ERR_INVALID_PARAM;
+    if (screen->count >= DISPLAY_WIDGET_MAX_COUNT) return DISPLAY_ERR_INVALID_PARAM;
+    if (parent != DISPLAY_WIDGET_NO_PARENT) {
+        /* Only containers can have children; requiring an existing parent keeps the array top-down */
+        if (parent >= screen->count) return DISPLAY_ERR_INVALID_PARAM;
+        if (screen->widgets[parent].kind != DISPLAY_WIDGET_CONTAINER) return DISPLAY_ERR_INVALID_PARAM;
+    }
+    if (!widget_fits_parent(screen, parent, x, y, w, h)) return DISPLAY_ERR_INVALID_PARAM;
+
+    DisplayWidget_Type *wd = &screen->widgets[screen->count];
+    memset(wd, 0, sizeof(*wd));
+    wd->kind = kind;
+    wd->parent = parent;
+    wd->x = x;
+    wd->y = y;
+    wd->w = w;
+    wd->h = h;
+    wd->visible = true;
+
+    *id = screen->count++;
+    *out = wd;
+    return DISPLAY_OK;
+}
+
+/* Children must lie inside their container: an erased child rect is then
+   always backed by an ancestor's background */
+static bool widget_fits_parent(const DisplayWidget_ScreenType *screen, uint8_t parent,
+                               uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    if (parent == DISPLAY_WIDGET_NO_PARENT) return true;
+    const DisplayWidget_Type *pw = &screen->widgets[parent];
+    return (uint32_t)x + w <= pw->w && (uint32_t)y + h <= pw->h;
+}
+
+/* Returns true when the bound value differs from what is on screen */
+static bool widget_sample(DisplayWidget_Type *wd) {
+    switch (wd->kind) {
+        case DISPLAY_WIDGET_PROGRESS:
+        case DISPLAY_WIDGET_NUMBER:
+        case DISPLAY_WIDGET_GEAR: {
+            int32_t v = wd->source.read(wd->source.ctx);
+            if (wd->drawn && v == wd->lastValue) return false;
+            wd->lastValue = v;
+            return true;
+        }
+        case DISPLAY_WIDGET_LABEL:
+            if (wd->drawn && strncmp(wd->text, wd->lastText, wd->maxChars) == 0) return false;
+            strncpy(wd->lastText, wd->text, wd->maxChars);
+            wd->lastText[wd->maxChars] = '\0';
+            return true;
+        case DISPLAY_WIDGET_CONTAINER:
+        default:
+            return false;
+    }
+}
+
+static bool widget_is_ancestor(const DisplayWidget_ScreenType *screen, uint8_t ancestor, uint8_t id) {
+    uint8_t p = screen->widgets[id].parent;
+    while (p != DISPLAY_WIDGET_NO_PARENT) {
+        if (p == ancestor) return true;
+        p = screen->widgets[p].parent;
+    }
+    return false;
+}
+
+/* Background a widget paints its cell with; the parent is on screen whenever the widget is */
+static uint32_t widget_background(const DisplayWidget_ScreenType *screen, const DisplayWidget_Type *wd) {
+    if (wd->parent == DISPLAY_WIDGET_NO_PARENT) return screen->background;
+    return screen->widgets[wd->parent].background;
+}
+
+/* Color under a widget's old rect: the nearest ancestor that stays where it is on screen.
+   Ancestors that are hidden or being erased themselves are skipped. */
+static uint32_t widget_erase_color(const DisplayWidget_ScreenType *screen, const DisplayWidget_Type *wd,
+                                   const bool *shown, const bool *erasing) {
+    uint8_t p = wd->parent;
+    while (p != DISPLAY_WIDGET_NO_PARENT) {
+        if (shown[p] && !erasing[p]) return screen->widgets[p].background;
+        p = screen->widgets[p].parent;
+    }
+    return screen->background;
+}
+
+static inline bool rect_overlap(uint16_t ax, uint16_t ay, uint16_t aw, uint16_t ah,
+                                uint16_t bx, uint16_t by, uint16_t bw, uint16_t bh) {
+    if ((uint32_t)ax + aw <= bx || (uint32_t)bx + bw <= ax) return false;
+    if ((uint32_t)ay + ah <= by || (uint32_t)by + bh <= ay) return false;
+    return true;
+}
+
+static Display_ReturnType widget_draw(DisplayWidget_ScreenType *screen, DisplayWidget_Type *wd) {
+    switch (wd->kind) {
+        case DISPLAY_WIDGET_CONTAINER:
+            return Display_FillRect(screen->display, wd->absX, wd->absY, wd->w, wd->h, wd->background);
+
+        case DISPLAY_WIDGET_PROGRESS: {
+            int32_t v = wd->lastValue;
+            if (v < 0) v = 0;
+            if (v > 100) v = 100;
+            return Display_DrawProgress(screen->display, wd->absX, wd->absY, wd->w, wd->h, (uint8_t)v);
+        }
+
+        case DISPLAY_WIDGET_NUMBER: {
+            /* Right-aligned in its digit cells; values that do not fit show "---" */
+            char buf[16];
+            int len = snprintf(buf, sizeof(buf), "%ld", (long)wd->lastValue);
+            if (len < 0) return DISPLAY_ERR_INVALID_PARAM;
+            if (len > wd->maxChars) {
+                memset(buf, '-', wd->maxChars);
+                buf[wd->maxChars] = '\0';
+                len = wd->maxChars;
+            }
+            return widget_draw_text(screen, wd, (uint16_t)((wd->maxChars - len) * DISPLAY_WIDGET_GLYPH_W), buf);
+        }
+
+        case DISPLAY_WIDGET_LABEL:
+            return widget_draw_text(screen, wd, 0, wd->lastText);
+
+        case DISPLAY_WIDGET_GEAR: {
+            static const char gear_chars[] = "PRND123";
+            char buf[2] = { '-', '\0' };
+            if (wd->lastValue >= 0 && wd->lastValue < (int32_t)(sizeof(gear_chars) - 1)) buf[0] = gear_chars[wd->lastValue];
+            return widget_draw_text(screen, wd, 0, buf);
+        }
+
+        default:
+            return DISPLAY_ERR_INVALID_PARAM;
+    }
+}
+
+static Display_ReturnType widget_draw_text(DisplayWidget_ScreenType *screen, DisplayWidget_Type *wd, uint16_t offset, const char *text) {
+    Display_ReturnType ret = Display_FillRect(screen->display, wd->absX, wd->absY, wd->w, wd->h, widget_background(screen, wd));
+    if (ret != DISPLAY_OK) return ret;
+    if (*text == '\0') return DISPLAY_OK;
+    return Display_DrawText(screen->display, (uint16_t)(wd->absX + offset), wd->absY, text);
+}
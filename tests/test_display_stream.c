@@ -0,0 +1,248 @@
+#define _POSIX_C_SOURCE 200809L
+#include "display_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* Stream tests: decoded frames must match the encoded ones bit for bit,
+   including after a failed write or a damaged byte, when joining
+   mid-stream, and when a mirror queue drops frames for a slow reader. */
+
+#define W 160
+#define H 96
+#define FRAMES 40
+#define PIXELS ((size_t)W * H)
+
+static uint32_t g_frames[FRAMES][PIXELS];
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); ++g_failures; } \
+} while (0)
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+    int calls;
+    int failAt;      /* data write call that fails, -1 = never */
+} MemSink;
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+} MemSource;
+
+static int mem_write(void *ctx, const void *data, size_t len) {
+    MemSink *m = (MemSink *)ctx;
+    if (data == NULL) return 0;
+    bool fail = (m->calls++ == m->failAt);
+    if (fail) len /= 2; /* short write: half the chunk reaches the medium */
+    if (m->len + len > m->cap) {
+        m->cap = (m->len + len) * 2;
+        m->data = (uint8_t *)realloc(m->data, m->cap);
+    }
+    memcpy(&m->data[m->len], data, len);
+    m->len += len;
+    return fail ? -1 : 0;
+}
+
+static size_t mem_read(void *ctx, void *data, size_t max) {
+    MemSource *m = (MemSource *)ctx;
+    size_t n = m->len - m->pos;
+    if (n > max) n = max;
+    memcpy(data, &m->data[m->pos], n);
+    m->pos += n;
+    return n;
+}
+
+/* Cluster-like content: flat background, a moving bar, a digit block, and
+   a noisy patch every 8th frame */
+static void make_frames(void) {
+    srand(1234);
+    for (int f = 0; f < FRAMES; ++f) {
+        uint32_t *fb = g_frames[f];
+        for (size_t i = 0; i < PIXELS; ++i) fb[i] = 0x00202020u;
+        for (int y = 70; y < 80; ++y)
+            for (int x = 10; x < 10 + f * 3; ++x) fb[y * W + x] = 0x0000FF00u;
+        for (int y = 20; y < 27; ++y)
+            for (int x = 60; x < 60 + (f % 4) * 6; ++x) fb[y * W + x] = 0xFFFFFFFFu;
+        if (f % 8 == 5) {
+            for (int y = 0; y < 40; ++y)
+                for (int x = 100; x < 150; ++x) fb[y * W + x] = (uint32_t)rand();
+        }
+    }
+}
+
+static void encode_all(MemSink *sink, uint32_t keyframeInterval, DisplayStream_EncoderType *enc) {
+    CHECK(DisplayStream_EncoderInit(enc, mem_write, sink, W, H, keyframeInterval) == DISPLAY_STREAM_OK);
+    for (int f = 0; f < FRAMES; ++f) (void)DisplayStream_EncodeFrame(enc, g_frames[f]);
+    CHECK(DisplayStream_EncoderDeinit(enc) == DISPLAY_STREAM_OK);
+}
+
+/* Decodes the whole source; returns the number of frames and checks each against g_frames */
+static int decode_all(MemSource *src, uint32_t *firstFrameNo, uint32_t *skipped) {
+    static DisplayStream_DecoderType dec;
+    int count = 0;
+    if (DisplayStream_DecoderInit(&dec, mem_read, src) != DISPLAY_STREAM_OK) return -1;
+    CHECK(dec.width == W && dec.height == H);
+
+    DisplayStream_ReturnType ret;
+    while ((ret = DisplayStream_DecodeFrame(&dec)) == DISPLAY_STREAM_OK) {
+        if (count == 0 && firstFrameNo) *firstFrameNo = dec.frameNo;
+        CHECK(dec.frameNo < FRAMES);
+        if (dec.frameNo < FRAMES) CHECK(memcmp(dec.frame, g_frames[dec.frameNo], sizeof(g_frames[0])) == 0);
+        ++count;
+    }
+    CHECK(ret == DISPLAY_STREAM_END);
+    if (skipped) *skipped = dec.skippedFrames;
+    DisplayStream_DecoderDeinit(&dec);
+    return count;
+}
+
+static void test_round_trip(void) {
+    static DisplayStream_EncoderType enc;
+    MemSink sink = { NULL, 0, 0, 0, -1 };
+    encode_all(&sink, 10, &enc);
+
+    MemSource src = { sink.data, sink.len, 0 };
+    CHECK(decode_all(&src, NULL, NULL) == FRAMES);
+    CHECK(enc.rawBytes / enc.encodedBytes >= 4);
+    free(sink.data);
+}
+
+static void test_failed_write_resumes_at_keyframe(void) {
+    static DisplayStream_EncoderType enc;
+    MemSink sink = { NULL, 0, 0, 0, -1 };
+
+    /* Find the first data write of frame 5 (a noisy, multi-chunk frame), then fail the one after it */
+    CHECK(DisplayStream_EncoderInit(&enc, mem_write, &sink, W, H, 0) == DISPLAY_STREAM_OK);
+    for (int f = 0; f < 5; ++f) (void)DisplayStream_EncodeFrame(&enc, g_frames[f]);
+    DisplayStream_EncoderDeinit(&enc);
+    int failAt = sink.calls + 1;
+    free(sink.data);
+
+    MemSink failing = { NULL, 0, 0, 0, failAt };
+    CHECK(DisplayStream_EncoderInit(&enc, mem_write, &failing, W, H, 0) == DISPLAY_STREAM_OK);
+    for (int f = 0; f < FRAMES; ++f) {
+        DisplayStream_ReturnType ret = DisplayStream_EncodeFrame(&enc, g_frames[f]);
+        CHECK(ret == ((f == 5) ? DISPLAY_STREAM_ERR_IO : DISPLAY_STREAM_OK));
+    }
+    DisplayStream_EncoderDeinit(&enc);
+
+    /* Frames 0-4 decode, frame 5 is lost, 6 is the recovery keyframe, everything after follows */
+    uint32_t skipped = 0;
+    MemSource src = { failing.data, failing.len, 0 };
+    CHECK(decode_all(&src, NULL, &skipped) == FRAMES - 1);
+    CHECK(skipped == 1);
+    free(failing.data);
+}
+
+static void test_flipped_byte_resumes_at_keyframe(void) {
+    static DisplayStream_EncoderType enc;
+    static DisplayStream_DecoderType dec;
+    MemSink sink = { NULL, 0, 0, 0, -1 };
+    size_t frame3 = 0;
+
+    CHECK(DisplayStream_EncoderInit(&enc, mem_write, &sink, W, H, 10) == DISPLAY_STREAM_OK);
+    for (int f = 0; f < FRAMES; ++f) {
+        if (f == 3) frame3 = sink.len;
+        (void)DisplayStream_EncodeFrame(&enc, g_frames[f]);
+    }
+    DisplayStream_EncoderDeinit(&enc);
+
+    /* Delta frame 3: magic, frameNo, y, x0, count, first token, then its first pixel value at byte 18 */
+    CHECK(memcmp(&sink.data[frame3], "DSDF", 4) == 0);
+    sink.data[frame3 + 18] ^= 0x01;
+
+    /* Frames 0-2 decode, 3 is dropped, 4-9 are deltas on top of it, decoding resumes at keyframe 10 */
+    MemSource src = { sink.data, sink.len, 0 };
+    uint32_t expected = 0;
+    int decoded = 0;
+    CHECK(DisplayStream_DecoderInit(&dec, mem_read, &src) == DISPLAY_STREAM_OK);
+    while (DisplayStream_DecodeFrame(&dec) == DISPLAY_STREAM_OK) {
+        CHECK(dec.frameNo == expected);
+        if (dec.frameNo < FRAMES) CHECK(memcmp(dec.frame, g_frames[dec.frameNo], sizeof(g_frames[0])) == 0);
+        expected = (dec.frameNo == 2) ? 10 : dec.frameNo + 1;
+        ++decoded;
+    }
+    CHECK(decoded == FRAMES - 7);
+    CHECK(dec.skippedFrames == 1);
+    DisplayStream_DecoderDeinit(&dec);
+    free(sink.data);
+}
+
+static void test_late_join(void) {
+    static DisplayStream_EncoderType enc;
+    MemSink sink = { NULL, 0, 0, 0, -1 };
+    encode_all(&sink, 10, &enc);
+
+    /* Start reading a few bytes into the stream, as a mirror attaching mid-frame would */
+    uint32_t first = 0;
+    MemSource src = { sink.data, sink.len, 7 };
+    CHECK(decode_all(&src, &first, NULL) == FRAMES - 10);
+    CHECK(first == 10);
+    free(sink.data);
+}
+
+static void test_queue_drops_instead_of_blocking(void) {
+    static DisplayStream_EncoderType enc;
+    static DisplayStream_QueueType q;
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    /* Nobody reads while encoding: EncodeFrame must never block */
+    CHECK(DisplayStream_QueueInit(&q, fds[0], 16 * 1024) == DISPLAY_STREAM_OK);
+    CHECK(DisplayStream_EncoderInit(&enc, DisplayStream_QueueWrite, &q, W, H, 0) == DISPLAY_STREAM_OK);
+    for (int round = 0; round < 20; ++round) {
+        for (int f = 0; f < FRAMES; ++f) {
+            uint32_t *fb = g_frames[(f + round) % FRAMES];
+            (void)DisplayStream_EncodeFrame(&enc, fb);
+        }
+    }
+    CHECK(q.droppedFrames > 0);
+
+    /* Drain everything that was queued and check that whole frames arrived intact */
+    MemSink received = { NULL, 0, 0, 0, -1 };
+    uint8_t buf[4096];
+    for (;;) {
+        (void)DisplayStream_QueuePump(&q);
+        ssize_t n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0 && q.len == 0) break;
+        if (n > 0) mem_write(&received, buf, (size_t)n);
+    }
+
+    static DisplayStream_DecoderType dec;
+    MemSource src = { received.data, received.len, 0 };
+    int decoded = 0;
+    CHECK(DisplayStream_DecoderInit(&dec, mem_read, &src) == DISPLAY_STREAM_OK);
+    while (DisplayStream_DecodeFrame(&dec) == DISPLAY_STREAM_OK) {
+        /* Frame n of the encoder showed g_frames[(n % FRAMES + n / FRAMES) % FRAMES] */
+        uint32_t n = dec.frameNo;
+        CHECK(memcmp(dec.frame, g_frames[(n % FRAMES + n / FRAMES) % FRAMES], sizeof(g_frames[0])) == 0);
+        ++decoded;
+    }
+    CHECK(decoded > 0);
+    CHECK(dec.skippedFrames == 0);
+
+    DisplayStream_DecoderDeinit(&dec);
+    DisplayStream_EncoderDeinit(&enc);
+    DisplayStream_QueueDeinit(&q);
+    free(received.data);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main(void) {
+    make_frames();
+    test_round_trip();
+    test_failed_write_resumes_at_keyframe();
+    test_flipped_byte_resumes_at_keyframe();
+    test_late_join();
+    test_queue_drops_instead_of_blocking();
+    printf("test_display_stream: %s\n", g_failures ? "FAILED" : "OK");
+    return g_failures ? 1 : 0;
+}
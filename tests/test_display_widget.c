@@ -0,0 +1,187 @@
+#include "display_widget.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Widget layer tests: every incremental update must leave the screen exactly
+   as a full repaint (Display_Clear + DisplayWidget_Invalidate) would. */
+
+#define FB_PIXELS ((size_t)800 * 480)
+
+static uint32_t *g_last_frame = NULL;
+static uint32_t g_flush_count = 0;
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); ++g_failures; } \
+} while (0)
+
+static void capture_hook(const uint32_t *framebuffer, uint16_t width, uint16_t height, void *ctx) {
+    (void)ctx;
+    memcpy(g_last_frame, framebuffer, (size_t)width * height * sizeof(uint32_t));
+    ++g_flush_count;
+}
+
+/* Returns the number of pixels where the incremental result differs from a full repaint */
+static size_t diff_against_full_repaint(DisplayWidget_ScreenType *screen) {
+    static uint32_t incremental[FB_PIXELS];
+    memcpy(incremental, g_last_frame, sizeof(incremental));
+
+    (void)Display_Clear(screen->display);
+    (void)DisplayWidget_Invalidate(screen);
+    (void)DisplayWidget_Update(screen, NULL);
+
+    size_t diff = 0;
+    for (size_t i = 0; i < FB_PIXELS; ++i) diff += (incremental[i] != g_last_frame[i]);
+    return diff;
+}
+
+static void setup(Display_HandleType *display, DisplayWidget_ScreenType *screen) {
+    (void)Display_Clear(display);
+    (void)DisplayWidget_ScreenInit(screen, display, 0x00202020u);
+}
+
+static void test_unchanged_frame_is_free(Display_HandleType *display) {
+    DisplayWidget_ScreenType screen;
+    int32_t speed = 88;
+    uint8_t id, redrawn = 0;
+    setup(display, &screen);
+    DisplayWidget_AddNumber(&screen, DISPLAY_WIDGET_NO_PARENT, 10, 10, 3, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &speed }, &id);
+    DisplayWidget_AddNumber(&screen, DISPLAY_WIDGET_NO_PARENT, 10, 30, 3, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &speed }, &id);
+    DisplayWidget_Update(&screen, &redrawn);
+    CHECK(redrawn == 2);
+
+    uint32_t flushes = g_flush_count;
+    DisplayWidget_Update(&screen, &redrawn);
+    CHECK(redrawn == 0);
+    CHECK(g_flush_count == flushes);
+
+    speed = 89;
+    DisplayWidget_Update(&screen, &redrawn);
+    CHECK(redrawn == 2);
+    CHECK(g_flush_count == flushes + 1);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+}
+
+static void test_container_move(Display_HandleType *display) {
+    DisplayWidget_ScreenType screen;
+    int32_t rpm = 3500;
+    uint8_t box, id;
+    setup(display, &screen);
+    DisplayWidget_AddContainer(&screen, DISPLAY_WIDGET_NO_PARENT, 100, 100, 120, 60, 0x00103050u, &box);
+    DisplayWidget_AddNumber(&screen, box, 10, 10, 4, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &rpm }, &id);
+    DisplayWidget_Update(&screen, NULL);
+
+    DisplayWidget_SetPosition(&screen, box, 140, 120);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+}
+
+static void test_hide_nested_container(Display_HandleType *display) {
+    DisplayWidget_ScreenType screen;
+    int32_t rpm = 3500;
+    uint8_t outer, inner, id;
+    setup(display, &screen);
+    DisplayWidget_AddContainer(&screen, DISPLAY_WIDGET_NO_PARENT, 50, 50, 300, 200, 0x00103050u, &outer);
+    DisplayWidget_AddContainer(&screen, outer, 20, 20, 100, 50, 0x00505010u, &inner);
+    DisplayWidget_AddNumber(&screen, inner, 5, 5, 4, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &rpm }, &id);
+    DisplayWidget_Update(&screen, NULL);
+
+    DisplayWidget_SetVisible(&screen, outer, false);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+
+    DisplayWidget_SetVisible(&screen, outer, true);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+}
+
+static void test_repaint_keeps_overlapping_widget_on_top(Display_HandleType *display) {
+    DisplayWidget_ScreenType screen;
+    uint8_t soc = 40;
+    char text[] = "RANGE";
+    uint8_t id;
+    setup(display, &screen);
+    DisplayWidget_AddProgress(&screen, DISPLAY_WIDGET_NO_PARENT, 20, 20, 200, 20, (DisplayWidget_SourceType){ DisplayWidget_ReadUInt8, &soc }, &id);
+    DisplayWidget_AddLabel(&screen, DISPLAY_WIDGET_NO_PARENT, 30, 25, 8, text, &id);
+    DisplayWidget_Update(&screen, NULL);
+
+    soc = 75;
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+}
+
+static void test_container_moves_under_later_sibling(Display_HandleType *display) {
+    DisplayWidget_ScreenType screen;
+    uint8_t a, b;
+    setup(display, &screen);
+    DisplayWidget_AddContainer(&screen, DISPLAY_WIDGET_NO_PARENT, 10, 10, 70, 70, 0x00AA0000u, &a);
+    DisplayWidget_AddContainer(&screen, DISPLAY_WIDGET_NO_PARENT, 200, 200, 70, 70, 0x0000AA00u, &b);
+    DisplayWidget_Update(&screen, NULL);
+
+    DisplayWidget_SetPosition(&screen, a, 220, 220);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+
+    DisplayWidget_SetPosition(&screen, a, 10, 10);
+    DisplayWidget_Update(&screen, NULL);
+    DisplayWidget_SetPosition(&screen, a, 190, 190);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(diff_against_full_repaint(&screen) == 0);
+}
+
+static void test_children_stay_inside_parent(Display_HandleType *display) {
+    DisplayWidget_ScreenType screen;
+    int32_t rpm = 0;
+    uint8_t box, id;
+    setup(display, &screen);
+    DisplayWidget_AddContainer(&screen, DISPLAY_WIDGET_NO_PARENT, 0, 0, 60, 20, 0x00103050u, &box);
+    CHECK(DisplayWidget_AddNumber(&screen, box, 40, 5, 4, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &rpm }, &id) == DISPLAY_ERR_INVALID_PARAM);
+    CHECK(DisplayWidget_AddNumber(&screen, box, 0, 5, 4, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &rpm }, &id) == DISPLAY_OK);
+    CHECK(DisplayWidget_SetPosition(&screen, id, 40, 5) == DISPLAY_ERR_INVALID_PARAM);
+    CHECK(DisplayWidget_SetPosition(&screen, id, 30, 10) == DISPLAY_OK);
+}
+
+static void test_number_overflow_marker(Display_HandleType *display) {
+    static uint32_t number_frame[FB_PIXELS];
+    DisplayWidget_ScreenType screen;
+    int32_t temp = -123;
+    uint8_t id;
+
+    setup(display, &screen);
+    DisplayWidget_AddNumber(&screen, DISPLAY_WIDGET_NO_PARENT, 10, 10, 3, (DisplayWidget_SourceType){ DisplayWidget_ReadInt32, &temp }, &id);
+    DisplayWidget_Update(&screen, NULL);
+    memcpy(number_frame, g_last_frame, sizeof(number_frame));
+
+    setup(display, &screen);
+    DisplayWidget_AddLabel(&screen, DISPLAY_WIDGET_NO_PARENT, 10, 10, 3, "---", &id);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(memcmp(number_frame, g_last_frame, sizeof(number_frame)) == 0);
+
+    setup(display, &screen);
+    DisplayWidget_AddLabel(&screen, DISPLAY_WIDGET_NO_PARENT, 10, 10, 3, "123", &id);
+    DisplayWidget_Update(&screen, NULL);
+    CHECK(memcmp(number_frame, g_last_frame, sizeof(number_frame)) != 0);
+}
+
+int main(void) {
+    Display_HandleType display;
+    memset(&display, 0, sizeof(display));
+    g_last_frame = (uint32_t *)calloc(FB_PIXELS, sizeof(uint32_t));
+    if (g_last_frame == NULL || Display_Init(&display) != DISPLAY_OK) return 1;
+    Display_SetFlushHook(capture_hook, NULL);
+
+    test_unchanged_frame_is_free(&display);
+    test_container_move(&display);
+    test_hide_nested_container(&display);
+    test_repaint_keeps_overlapping_widget_on_top(&display);
+    test_container_moves_under_later_sibling(&display);
+    test_children_stay_inside_parent(&display);
+    test_number_overflow_marker(&display);
+
+    Display_SetFlushHook(NULL, NULL);
+    Display_Deinit(&display);
+    free(g_last_frame);
+    printf("test_display_widget: %s\n", g_failures ? "FAILED" : "OK");
+    return g_failures ? 1 : 0;
+}